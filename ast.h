@@ -5,13 +5,34 @@
 #include <string>
 #include <memory>
 #include <variant>
+#include <string_view>
+#include "memory.h"
 
-using Value = std::variant<int, std::string>;
+using String = std::basic_string<char, std::char_traits<char>, CountingAllocator<char, MemCategory::STRING>>;
+using Value = std::variant<int, String>;
+
+// 标识符：AST、作用域和函数表共用同一类型，查找时无需转换
+using Name = std::basic_string<char, std::char_traits<char>, CountingAllocator<char, MemCategory::NAME>>;
+struct NameHash {
+	size_t operator()(const Name& n) const { return std::hash<std::string_view>()(std::string_view(n.data(), n.size())); }
+};
+inline std::string to_string(const Name& n) { return std::string(n.data(), n.size()); }
+
+using AstString = std::basic_string<char, std::char_traits<char>, CountingAllocator<char, MemCategory::AST>>;
+template <class T> using AstVector = std::vector<T, CountingAllocator<T, MemCategory::AST>>;
 
 // ------------------ AST ------------------
-struct Expr { virtual ~Expr() {} };
+// AST 节点及其字面量、子节点数组的内存计入 MemCategory::AST，标识符计入 MemCategory::NAME
+struct Node {
+	virtual ~Node() {}
+	static void* operator new(size_t n) { return mem_allocate(MemCategory::AST, n); }
+	static void operator delete(void* p, size_t n) { mem_deallocate(MemCategory::AST, p, n); }
+};
+struct Expr : Node {
+	signed char calls = -1;          // 子树是否含函数调用，由解释器分析后缓存
+};
 struct NumberExpr : Expr { int value; explicit NumberExpr(int v) :value(v) {} };
-struct VarExpr : Expr { std::string name; explicit VarExpr(std::string n) :name(std::move(n)) {} };
+struct VarExpr : Expr { Name name; explicit VarExpr(Name n) :name(std::move(n)) {} };
 struct BinaryExpr : Expr {
 	std::string op; std::unique_ptr<Expr> left, right;
 	BinaryExpr(std::string o, std::unique_ptr<Expr> l, std::unique_ptr<Expr> r)
@@ -19,44 +40,54 @@ struct BinaryExpr : Expr {
 	}
 };
 struct AssignExpr : Expr {
-	std::string name; std::unique_ptr<Expr> value;
-	AssignExpr(std::string n, std::unique_ptr<Expr> v)
+	Name name; std::unique_ptr<Expr> value;
+	AssignExpr(Name n, std::unique_ptr<Expr> v)
 		: name(std::move(n)), value(std::move(v)) {
 	}
 };
 struct StringExpr : Expr {
-	std::string value;
-	explicit StringExpr(std::string v) : value(std::move(v)) {}
+	AstString value;
+	explicit StringExpr(AstString v) : value(std::move(v)) {}
 };
 struct CallExpr : Expr {
-	std::string name;
-	std::vector<std::unique_ptr<Expr>> args;
-	CallExpr(std::string n, std::vector<std::unique_ptr<Expr>> a) : name(std::move(n)), args(std::move(a)) {}
+	Name name;
+	AstVector<std::unique_ptr<Expr>> args;
+	CallExpr(Name n, AstVector<std::unique_ptr<Expr>> a) : name(std::move(n)), args(std::move(a)) {}
 };
 
-struct Stmt { virtual ~Stmt() {} };
-struct BlockStmt : Stmt { std::vector<std::unique_ptr<Stmt>> stmts; };
-struct PrintStmt : Stmt { std::vector<std::unique_ptr<Expr>> exprs; explicit PrintStmt(std::vector<std::unique_ptr<Expr>> e) :exprs(std::move(e)) {} };
+struct Stmt : Node {};
+struct BlockStmt : Stmt { AstVector<std::unique_ptr<Stmt>> stmts; };
+struct PrintStmt : Stmt { AstVector<std::unique_ptr<Expr>> exprs; explicit PrintStmt(AstVector<std::unique_ptr<Expr>> e) :exprs(std::move(e)) {} };
 struct LetStmt : Stmt {
-	std::string name; std::unique_ptr<Expr> expr;
-	LetStmt(std::string n, std::unique_ptr<Expr> e) :name(std::move(n)), expr(std::move(e)) {}
+	Name name; std::unique_ptr<Expr> expr;
+	LetStmt(Name n, std::unique_ptr<Expr> e) :name(std::move(n)), expr(std::move(e)) {}
 };
 struct IfStmt : Stmt { std::unique_ptr<Expr> cond; std::unique_ptr<Stmt> thenStmt, elseStmt; };
+// for (let i = a; i < b; i++) 形式的计数循环，分析结果缓存在 ForStmt 上
+struct CountedLoop {
+	enum class Cmp { LT, LE, GT, GE, NE };
+	enum class State { UNKNOWN, GENERAL, COUNTED } state = State::UNKNOWN;
+	Name var;                        // 循环变量
+	Cmp cmp = Cmp::LT;
+	Expr* bound = nullptr;           // NumberExpr 或循环体内不被写入的 VarExpr
+	int delta = 0;                   // 每次迭代的步长
+};
 struct ForStmt : Stmt {
 	std::unique_ptr<Stmt> init;      // let 语句
 	std::unique_ptr<Expr> cond;      // 表达式
 	std::unique_ptr<Expr> step;      // 赋值表达式
 	std::unique_ptr<Stmt> body;      // 语句或块
+	CountedLoop counted;
 };
 struct AssignStmt : Stmt {
 	std::unique_ptr<AssignExpr> assign;
 	explicit AssignStmt(std::unique_ptr<AssignExpr> a) : assign(std::move(a)) {}
 };
 struct FunctionDefStmt : Stmt {
-	std::string name;
-	std::vector<std::string> params;
+	Name name;
+	AstVector<Name> params;
 	std::unique_ptr<Stmt> body;
-	FunctionDefStmt(std::string n, std::vector<std::string> p, std::unique_ptr<Stmt> b)
+	FunctionDefStmt(Name n, AstVector<Name> p, std::unique_ptr<Stmt> b)
 		: name(std::move(n)), params(std::move(p)), body(std::move(b)) {
 	}
 };
@@ -68,5 +99,10 @@ struct ExprStmt : Stmt {
 	std::unique_ptr<Expr> expr;
 	explicit ExprStmt(std::unique_ptr<Expr> e) : expr(std::move(e)) {}
 };
+struct SpawnStmt : Stmt {
+	std::unique_ptr<CallExpr> call;  // 在新协程中执行的函数调用
+	explicit SpawnStmt(std::unique_ptr<CallExpr> c) : call(std::move(c)) {}
+};
+struct YieldStmt : Stmt {};
 
 #endif // AST_H
\ No newline at end of file
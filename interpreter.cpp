@@ -3,81 +3,201 @@
 #include <stdexcept>
 #include <string>
 
+static String int_string(int v) {
+    std::string s = std::to_string(v);
+    return String(s.data(), s.size());
+}
+
+static Value binary(const std::string& op, const Value& l, const Value& r) {
+    if (op == "+") {
+        if (std::holds_alternative<String>(l) || std::holds_alternative<String>(r)) {
+            String ls = std::holds_alternative<int>(l) ? int_string(std::get<int>(l)) : std::get<String>(l);
+            String rs = std::holds_alternative<int>(r) ? int_string(std::get<int>(r)) : std::get<String>(r);
+            return ls + rs;
+        }
+        else {
+            return std::get<int>(l) + std::get<int>(r);
+        }
+    }
+    bool is_string = std::holds_alternative<String>(l) && std::holds_alternative<String>(r);
+    if (is_string) {
+        const String& ls = std::get<String>(l);
+        const String& rs = std::get<String>(r);
+        if (op == "==") return ls == rs;
+        if (op == "!=") return ls != rs;
+        if (op == "<") return ls < rs;
+        if (op == ">") return ls > rs;
+        if (op == "<=") return ls <= rs;
+        if (op == ">=") return ls >= rs;
+        throw std::runtime_error("invalid operator for strings: " + op);
+    }
+    else {
+        int li = std::get<int>(l), ri = std::get<int>(r);
+        if (op == "-") return li - ri;
+        if (op == "*") return li * ri;
+        if (op == "/") {
+             if (ri == 0) throw std::runtime_error("division by zero");
+             return li / ri;
+        }
+        if (op == "%") {
+             if (ri == 0) throw std::runtime_error("modulo by zero");
+             return li % ri;
+        }
+        if (op == "==") return li == ri;
+        if (op == "!=") return li != ri;
+        if (op == "<") return li < ri;
+        if (op == ">") return li > ri;
+        if (op == "<=") return li <= ri;
+        if (op == ">=") return li >= ri;
+        throw std::runtime_error("unknown operator: " + op);
+    }
+}
+
+static void print_value(const Value& val) {
+    if (std::holds_alternative<int>(val))
+        std::cout << std::get<int>(val);
+    else
+        std::cout << std::get<String>(val);
+}
+
+// 表达式子树是否含函数调用，结果缓存在节点上。不含调用的表达式不会挂起，协程中可以直接求值。
+static bool has_call(Expr* e) {
+    if (e->calls < 0) {
+        bool c = dynamic_cast<CallExpr*>(e) != nullptr;
+        if (auto a = dynamic_cast<AssignExpr*>(e)) c = has_call(a->value.get());
+        else if (auto b = dynamic_cast<BinaryExpr*>(e)) c = has_call(b->left.get()) || has_call(b->right.get());
+        e->calls = c;
+    }
+    return e->calls != 0;
+}
+
+// 判断表达式/语句是否可能写入变量 name。
+// 函数调用采用动态作用域，可能改写调用者的变量，因此保守地视为写入。
+static bool may_write(Expr* e, const Name& name) {
+    if (!e) return false;
+    if (auto a = dynamic_cast<AssignExpr*>(e)) return a->name == name || may_write(a->value.get(), name);
+    if (auto b = dynamic_cast<BinaryExpr*>(e)) return may_write(b->left.get(), name) || may_write(b->right.get(), name);
+    if (dynamic_cast<CallExpr*>(e)) return true;
+    return false;
+}
+
+static bool may_write(Stmt* s, const Name& name) {
+    if (!s) return false;
+    if (auto p = dynamic_cast<PrintStmt*>(s)) {
+        for (auto& expr : p->exprs) if (may_write(expr.get(), name)) return true;
+        return false;
+    }
+    if (auto l = dynamic_cast<LetStmt*>(s)) return l->name == name || may_write(l->expr.get(), name);
+    if (auto b = dynamic_cast<BlockStmt*>(s)) {
+        for (auto& stmt : b->stmts) if (may_write(stmt.get(), name)) return true;
+        return false;
+    }
+    if (auto i = dynamic_cast<IfStmt*>(s))
+        return may_write(i->cond.get(), name) || may_write(i->thenStmt.get(), name) || may_write(i->elseStmt.get(), name);
+    if (auto f = dynamic_cast<ForStmt*>(s))
+        return may_write(f->init.get(), name) || may_write(f->cond.get(), name) ||
+            may_write(f->step.get(), name) || may_write(f->body.get(), name);
+    if (auto a = dynamic_cast<AssignStmt*>(s)) return may_write(a->assign.get(), name);
+    if (dynamic_cast<FunctionDefStmt*>(s)) return false;
+    if (auto r = dynamic_cast<ReturnStmt*>(s)) return may_write(r->expr.get(), name);
+    if (auto es = dynamic_cast<ExprStmt*>(s)) return may_write(es->expr.get(), name);
+    if (auto sp = dynamic_cast<SpawnStmt*>(s)) {
+        for (auto& arg : sp->call->args) if (may_write(arg.get(), name)) return true;
+        return false;
+    }
+    // yield 期间其他协程可能改写共享的全局变量
+    return true;
+}
+
+// 识别 for (let i = a; i < b; i++) 形式：
+// 条件为 i 与常量或循环不变量比较，步进为 i = i +/- 常量，且循环体不写 i 和上界变量
+static void analyze_for(ForStmt* f) {
+    CountedLoop& c = f->counted;
+    c.state = CountedLoop::State::GENERAL;
+
+    auto init = dynamic_cast<LetStmt*>(f->init.get());
+    auto cond = dynamic_cast<BinaryExpr*>(f->cond.get());
+    auto step = dynamic_cast<AssignExpr*>(f->step.get());
+    if (!init || !cond || !step) return;
+
+    const Name& var = init->name;
+    auto lhs = dynamic_cast<VarExpr*>(cond->left.get());
+    if (!lhs || lhs->name != var) return;
+    if (cond->op == "<") c.cmp = CountedLoop::Cmp::LT;
+    else if (cond->op == "<=") c.cmp = CountedLoop::Cmp::LE;
+    else if (cond->op == ">") c.cmp = CountedLoop::Cmp::GT;
+    else if (cond->op == ">=") c.cmp = CountedLoop::Cmp::GE;
+    else if (cond->op == "!=") c.cmp = CountedLoop::Cmp::NE;
+    else return;
+
+    auto bound_var = dynamic_cast<VarExpr*>(cond->right.get());
+    if (bound_var) {
+        if (bound_var->name == var || may_write(f->body.get(), bound_var->name)) return;
+    }
+    else if (!dynamic_cast<NumberExpr*>(cond->right.get())) return;
+
+    if (step->name != var) return;
+    auto inc = dynamic_cast<BinaryExpr*>(step->value.get());
+    if (!inc || (inc->op != "+" && inc->op != "-")) return;
+    auto inc_var = dynamic_cast<VarExpr*>(inc->left.get());
+    auto inc_num = dynamic_cast<NumberExpr*>(inc->right.get());
+    if (!inc_var || inc_var->name != var || !inc_num) return;
+
+    if (may_write(f->body.get(), var)) return;
+
+    c.var = var;
+    c.bound = cond->right.get();
+    c.delta = inc->op == "+" ? inc_num->value : -inc_num->value;
+    c.state = CountedLoop::State::COUNTED;
+}
+
 Value Interpreter::eval(Expr* e) {
     if (auto n = dynamic_cast<NumberExpr*>(e)) return n->value;
     if (auto v = dynamic_cast<VarExpr*>(e)) {
-        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-            auto f = it->find(v->name);
-            if (f != it->end()) return f->second;
-        }
-        throw std::runtime_error("undefined variable: " + v->name);
+        if (Value* val = lookup(v->name)) return *val;
+        throw std::runtime_error("undefined variable: " + to_string(v->name));
     }
     if (auto s = dynamic_cast<StringExpr*>(e)) {
-        return s->value;
+        return String(s->value.data(), s->value.size());
     }
     if (auto a = dynamic_cast<AssignExpr*>(e)) {
         Value val = eval(a->value.get());
-        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-            if (it->count(a->name)) {
-                (*it)[a->name] = val;
-                return val;
-            }
-        }
-        scopes.back()[a->name] = val;
+        assign(a->name, val);
         return val;
     }
     if (auto b = dynamic_cast<BinaryExpr*>(e)) {
         Value l = eval(b->left.get()), r = eval(b->right.get());
-        if (b->op == "+") {
-            if (std::holds_alternative<std::string>(l) || std::holds_alternative<std::string>(r)) {
-                std::string ls = std::holds_alternative<int>(l) ? std::to_string(std::get<int>(l)) : std::get<std::string>(l);
-                std::string rs = std::holds_alternative<int>(r) ? std::to_string(std::get<int>(r)) : std::get<std::string>(r);
-                return ls + rs;
-            }
-            else {
-                return std::get<int>(l) + std::get<int>(r);
-            }
-        }
-        bool is_string = std::holds_alternative<std::string>(l) && std::holds_alternative<std::string>(r);
-        if (is_string) {
-            const std::string& ls = std::get<std::string>(l);
-            const std::string& rs = std::get<std::string>(r);
-            if (b->op == "==") return ls == rs;
-            if (b->op == "!=") return ls != rs;
-            if (b->op == "<") return ls < rs;
-            if (b->op == ">") return ls > rs;
-            if (b->op == "<=") return ls <= rs;
-            if (b->op == ">=") return ls >= rs;
-            throw std::runtime_error("invalid operator for strings: " + b->op);
-        }
-        else {
-            int li = std::get<int>(l), ri = std::get<int>(r);
-            if (b->op == "-") return li - ri;
-            if (b->op == "*") return li * ri;
-            if (b->op == "/") {
-                 if (ri == 0) throw std::runtime_error("division by zero");
-                 return li / ri;
-            }
-            if (b->op == "%") {
-                 if (ri == 0) throw std::runtime_error("modulo by zero");
-                 return li % ri;
-            }
-            if (b->op == "==") return li == ri;
-            if (b->op == "!=") return li != ri;
-            if (b->op == "<") return li < ri;
-            if (b->op == ">") return li > ri;
-            if (b->op == "<=") return li <= ri;
-            if (b->op == ">=") return li >= ri;
-            throw std::runtime_error("unknown operator: " + b->op);
-        }
+        return binary(b->op, l, r);
     }
     if (auto c = dynamic_cast<CallExpr*>(e)) {
         auto it = funcs.find(c->name);
-        if (it == funcs.end()) throw std::runtime_error("undefined function: " + c->name);
-        auto& f = it->second;
-        if (f->params.size() != c->args.size()) throw std::runtime_error("argument count mismatch for " + c->name);
+        if (it == funcs.end()) {
+            // 内置通道操作：chan() 创建通道，send(ch, v) 不阻塞，recv(ch) 取出一个值
+            if (c->name == "chan" && c->args.empty()) return make_chan();
+            if (c->name == "send" && c->args.size() == 2) {
+                Channel& ch = channel(eval(c->args[0].get()));
+                send(ch, eval(c->args[1].get()));
+                return 0;
+            }
+            if (c->name == "recv" && c->args.size() == 1) {
+                Channel& ch = channel(eval(c->args[0].get()));
+                // 协程中的调用都按帧执行，只有主程序会走到这里：主程序无法挂起，
+                // 先让其他协程运行，就绪队列为空时才是真正的死锁
+                while (ch.items.empty()) {
+                    if (ready.empty()) throw std::runtime_error("deadlock: recv on empty channel with no runnable tasks");
+                    run_round();
+                }
+                Value val = std::move(ch.items.front());
+                ch.items.pop_front();
+                return val;
+            }
+            throw std::runtime_error("undefined function: " + to_string(c->name));
+        }
+        std::shared_ptr<Function> f = it->second;
+        if (f->params.size() != c->args.size()) throw std::runtime_error("argument count mismatch for " + to_string(c->name));
         std::vector<Value> arg_vals;
         for (auto& arg : c->args) arg_vals.push_back(eval(arg.get()));
+        size_t base = scopes.size();
         push_scope();
         for (size_t i = 0; i < f->params.size(); ++i) {
             scopes.back()[f->params[i]] = arg_vals[i];
@@ -89,7 +209,7 @@ Value Interpreter::eval(Expr* e) {
         catch (ReturnException& re) {
             ret = re.val;
         }
-        pop_scope();
+        scopes.resize(base); // return 可能跳过了函数体内块的出栈
         return ret;
     }
     throw std::runtime_error("unknown expression type");
@@ -102,16 +222,13 @@ void Interpreter::exec(Stmt* s) {
             Value val = eval(expr.get());
             if (!first) std::cout << " ";
             first = false;
-            if (std::holds_alternative<int>(val))
-                std::cout << std::get<int>(val);
-            else
-                std::cout << std::get<std::string>(val);
+            print_value(val);
         }
         std::cout << "\n";
     }
     else if (auto l = dynamic_cast<LetStmt*>(s)) {
         Value val = eval(l->expr.get());
-        scopes.back()[l->name] = val;
+        current_scope()[l->name] = val;
     }
     else if (auto b = dynamic_cast<BlockStmt*>(s)) {
         push_scope();
@@ -125,14 +242,17 @@ void Interpreter::exec(Stmt* s) {
         else if (i->elseStmt) exec(i->elseStmt.get());
     }
     else if (auto f = dynamic_cast<ForStmt*>(s)) {
+        if (f->counted.state == CountedLoop::State::UNKNOWN) analyze_for(f);
         push_scope();
         exec(f->init.get());
-        while (true) {
-            Value cond_val = eval(f->cond.get());
-            if (!std::holds_alternative<int>(cond_val)) throw std::runtime_error("for loop condition must be integer");
-            if (!std::get<int>(cond_val)) break;
-            exec(f->body.get());
-            (void)eval(f->step.get());
+        if (f->counted.state != CountedLoop::State::COUNTED || !exec_counted(f)) {
+            while (true) {
+                Value cond_val = eval(f->cond.get());
+                if (!std::holds_alternative<int>(cond_val)) throw std::runtime_error("for loop condition must be integer");
+                if (!std::get<int>(cond_val)) break;
+                exec(f->body.get());
+                (void)eval(f->step.get());
+            }
         }
         pop_scope();
     }
@@ -140,8 +260,8 @@ void Interpreter::exec(Stmt* s) {
         eval(a->assign.get());
     }
     else if (auto fd = dynamic_cast<FunctionDefStmt*>(s)) {
-        auto func = std::make_unique<Function>();
-        func->params = fd->params;
+        auto func = std::allocate_shared<Function>(CountingAllocator<Function, MemCategory::FUNCTION>());
+        func->params.assign(fd->params.begin(), fd->params.end());
         func->body = std::move(fd->body); // Transfer ownership of the body AST node
         funcs[fd->name] = std::move(func);
     }
@@ -152,6 +272,15 @@ void Interpreter::exec(Stmt* s) {
     else if (auto es = dynamic_cast<ExprStmt*>(s)) {
         eval(es->expr.get());
     }
+    else if (auto sp = dynamic_cast<SpawnStmt*>(s)) {
+        std::vector<Value> args;
+        for (auto& arg : sp->call->args) args.push_back(eval(arg.get()));
+        spawn(sp->call.get(), args);
+    }
+    else if (dynamic_cast<YieldStmt*>(s)) {
+        // 主程序中的 yield：让其他就绪协程各运行一次（协程中的 yield 由 step_stmt 处理）
+        run_round();
+    }
     else if (s == nullptr) {
         // Handle null statements gracefully (e.g., from parsing empty else block)
     }
@@ -160,8 +289,47 @@ void Interpreter::exec(Stmt* s) {
     }
 }
 
-Interpreter::Interpreter() {
-    push_scope(); // global scope
+// 计数循环的快速路径（init 已执行）：循环变量保存在本地 int 中，每次迭代只回写
+// 作用域里的槽位，不再对 cond/step 做通用求值。初值或上界不是整数时返回 false，
+// 交由通用路径处理。
+bool Interpreter::exec_counted(ForStmt* f) {
+    const CountedLoop& c = f->counted;
+    size_t depth = scopes.size() - 1;
+    Value* slot = &scopes[depth][c.var];
+    Value limit = eval(c.bound);
+    if (!std::holds_alternative<int>(*slot) || !std::holds_alternative<int>(limit)) return false;
+
+    // 循环体内的作用域压栈可能使 scopes 重新分配，此时重新定位槽位
+    const void* base = scopes.data();
+    int i = std::get<int>(*slot), bound = std::get<int>(limit);
+    while (true) {
+        bool go;
+        switch (c.cmp) {
+        case CountedLoop::Cmp::LT: go = i < bound; break;
+        case CountedLoop::Cmp::LE: go = i <= bound; break;
+        case CountedLoop::Cmp::GT: go = i > bound; break;
+        case CountedLoop::Cmp::GE: go = i >= bound; break;
+        default: go = i != bound; break;
+        }
+        if (!go) break;
+        if (scopes.data() != base) {
+            base = scopes.data();
+            slot = &scopes[depth].find(c.var)->second;
+        }
+        std::get<int>(*slot) = i;
+        exec(f->body.get());
+        i += c.delta;
+    }
+    return true;
+}
+
+std::shared_ptr<Function> Interpreter::function(const Name& name) const {
+    auto it = funcs.find(name);
+    return it != funcs.end() ? it->second : nullptr;
+}
+
+void Interpreter::recover() {
+    scopes.clear();
 }
 
 void Interpreter::push_scope() {
@@ -170,4 +338,353 @@ void Interpreter::push_scope() {
 
 void Interpreter::pop_scope() {
     scopes.pop_back();
-}
\ No newline at end of file
+}
+
+Scope& Interpreter::current_scope() {
+    return scopes.empty() ? globals : scopes.back();
+}
+
+Value* Interpreter::lookup(const Name& name) {
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+        auto f = it->find(name);
+        if (f != it->end()) return &f->second;
+    }
+    auto g = globals.find(name);
+    return g != globals.end() ? &g->second : nullptr;
+}
+
+void Interpreter::assign(const Name& name, const Value& val) {
+    if (Value* slot = lookup(name)) *slot = val;
+    else current_scope()[name] = val;
+}
+
+// ------------------ 协程 ------------------
+
+Channel& Interpreter::channel(const Value& id) {
+    if (!std::holds_alternative<int>(id) || std::get<int>(id) < 0 || std::get<int>(id) >= static_cast<int>(channels.size()))
+        throw std::runtime_error("invalid channel");
+    return channels[std::get<int>(id)];
+}
+
+Value Interpreter::make_chan() {
+    channels.emplace_back();
+    return static_cast<int>(channels.size() - 1);
+}
+
+void Interpreter::send(Channel& ch, Value val) {
+    ch.items.push_back(std::move(val));
+    if (!ch.waiters.empty()) {
+        ready.push_back(std::move(ch.waiters.front()));
+        ch.waiters.pop_front();
+    }
+}
+
+void Interpreter::spawn(CallExpr* c, std::vector<Value>& args) {
+    auto it = funcs.find(c->name);
+    if (it == funcs.end()) throw std::runtime_error("undefined function: " + to_string(c->name));
+    auto& f = it->second;
+    if (f->params.size() != args.size()) throw std::runtime_error("argument count mismatch for " + to_string(c->name));
+    auto t = std::make_unique<Task>();
+    t->scopes.emplace_back();
+    for (size_t i = 0; i < f->params.size(); ++i) {
+        t->scopes.back()[f->params[i]] = std::move(args[i]);
+    }
+    t->frames.push_back({ Frame::Kind::CALL, 0, f->body.get(), 0, 0, f });
+    ready.push_back(std::move(t));
+}
+
+static Value pop_value(Task& t) {
+    Value val = std::move(t.values.back());
+    t.values.pop_back();
+    return val;
+}
+
+// 不含调用的表达式直接求值压入值栈，否则压入 EXPR 帧逐步求值
+void Interpreter::push_expr(Task& t, Expr* e) {
+    if (!has_call(e)) t.values.push_back(eval(e));
+    else t.frames.push_back({ Frame::Kind::EXPR, 0, e });
+}
+
+// 从最近的 CALL 帧返回，丢弃函数体内尚未结束的帧、作用域和值，返回值压入值栈
+void Interpreter::finish_call(Task& t, Value val) {
+    while (t.frames.back().kind != Frame::Kind::CALL) t.frames.pop_back();
+    scopes.resize(t.frames.back().base);
+    t.values.resize(t.frames.back().vbase);
+    t.frames.pop_back();
+    t.values.push_back(std::move(val));
+}
+
+// 执行 EXPR 帧的一步。子表达式的值依次压入值栈，函数调用压入 CALL 帧，
+// recv 遇到空通道时 pc 保持不变并阻塞，唤醒后不会重复求值参数。
+Interpreter::Status Interpreter::step_expr(Task& t) {
+    Frame& fr = t.frames.back();
+    Expr* e = static_cast<Expr*>(fr.node);
+    if (auto b = dynamic_cast<BinaryExpr*>(e)) {
+        if (fr.pc == 0) {
+            fr.pc = 1;
+            push_expr(t, b->left.get());
+        }
+        else if (fr.pc == 1) {
+            fr.pc = 2;
+            push_expr(t, b->right.get());
+        }
+        else {
+            Value r = pop_value(t), l = pop_value(t);
+            t.frames.pop_back();
+            t.values.push_back(binary(b->op, l, r));
+        }
+    }
+    else if (auto a = dynamic_cast<AssignExpr*>(e)) {
+        if (fr.pc == 0) {
+            fr.pc = 1;
+            push_expr(t, a->value.get());
+        }
+        else {
+            assign(a->name, t.values.back());
+            t.frames.pop_back();
+        }
+    }
+    else if (auto c = dynamic_cast<CallExpr*>(e)) {
+        int argc = static_cast<int>(c->args.size());
+        if (fr.pc < argc) {
+            Expr* arg = c->args[fr.pc++].get();
+            push_expr(t, arg);
+            return Status::RUN;
+        }
+        if (fr.pc > argc) {
+            t.frames.pop_back(); // 函数返回值已在值栈顶
+            return Status::RUN;
+        }
+        auto it = funcs.find(c->name);
+        if (it != funcs.end()) {
+            std::shared_ptr<Function> f = it->second;
+            if (f->params.size() != c->args.size()) throw std::runtime_error("argument count mismatch for " + to_string(c->name));
+            size_t first = t.values.size() - argc;
+            size_t base = scopes.size();
+            push_scope();
+            for (size_t i = 0; i < f->params.size(); ++i) {
+                scopes.back()[f->params[i]] = std::move(t.values[first + i]);
+            }
+            t.values.resize(first);
+            fr.pc = argc + 1;
+            t.frames.push_back({ Frame::Kind::CALL, 0, f->body.get(),
+                static_cast<unsigned>(base), static_cast<unsigned>(first), f });
+        }
+        else if (c->name == "recv" && argc == 1) {
+            Channel& ch = channel(t.values.back());
+            if (ch.items.empty()) {
+                t.waiting = std::get<int>(t.values.back());
+                return Status::BLOCK;
+            }
+            t.values.back() = std::move(ch.items.front());
+            ch.items.pop_front();
+            t.frames.pop_back();
+        }
+        else if (c->name == "send" && argc == 2) {
+            Value val = pop_value(t);
+            send(channel(t.values.back()), std::move(val));
+            t.values.back() = 0;
+            t.frames.pop_back();
+        }
+        else if (c->name == "chan" && argc == 0) {
+            t.values.push_back(make_chan());
+            t.frames.pop_back();
+        }
+        else throw std::runtime_error("undefined function: " + to_string(c->name));
+    }
+    else {
+        t.values.push_back(eval(e));
+        t.frames.pop_back();
+    }
+    return Status::RUN;
+}
+
+// 执行 STMT/CALL 帧的一步。不含挂起点的语句直接交给 exec。
+Interpreter::Status Interpreter::step_stmt(Task& t) {
+    Frame& fr = t.frames.back();
+    if (fr.kind == Frame::Kind::CALL) {
+        if (fr.pc == 0) {
+            fr.pc = 1;
+            t.frames.push_back({ Frame::Kind::STMT, 0, fr.node });
+        }
+        else finish_call(t, 0); // 函数体执行完毕且没有 return
+        return Status::RUN;
+    }
+
+    Stmt* s = static_cast<Stmt*>(fr.node);
+    if (auto b = dynamic_cast<BlockStmt*>(s)) {
+        if (fr.pc == 0) push_scope();
+        if (fr.pc < static_cast<int>(b->stmts.size())) {
+            Stmt* next = b->stmts[fr.pc++].get();
+            t.frames.push_back({ Frame::Kind::STMT, 0, next });
+        }
+        else {
+            pop_scope();
+            t.frames.pop_back();
+        }
+    }
+    else if (auto i = dynamic_cast<IfStmt*>(s)) {
+        if (fr.pc == 0) {
+            fr.pc = 1;
+            push_expr(t, i->cond.get());
+            return Status::RUN;
+        }
+        Value val = pop_value(t);
+        if (!std::holds_alternative<int>(val)) throw std::runtime_error("if condition must be integer");
+        Stmt* next = std::get<int>(val) ? i->thenStmt.get() : i->elseStmt.get();
+        t.frames.pop_back();
+        if (next) t.frames.push_back({ Frame::Kind::STMT, 0, next });
+    }
+    else if (auto f = dynamic_cast<ForStmt*>(s)) {
+        // pc: 0 进入, 1 init 完成, 2 cond 已求值, 3 循环体完成, 4 step 已求值
+        switch (fr.pc) {
+        case 0:
+            if (f->counted.state == CountedLoop::State::UNKNOWN) analyze_for(f);
+            push_scope();
+            fr.pc = 1;
+            t.frames.push_back({ Frame::Kind::STMT, 0, f->init.get() });
+            break;
+        case 1:
+            // 计数循环的循环体不含调用和 yield，不会挂起，可以一次执行完
+            if (f->counted.state == CountedLoop::State::COUNTED && exec_counted(f)) {
+                pop_scope();
+                t.frames.pop_back();
+                break;
+            }
+            fr.pc = 2;
+            push_expr(t, f->cond.get());
+            break;
+        case 2: {
+            Value cond_val = pop_value(t);
+            if (!std::holds_alternative<int>(cond_val)) throw std::runtime_error("for loop condition must be integer");
+            if (!std::get<int>(cond_val)) {
+                pop_scope();
+                t.frames.pop_back();
+            }
+            else {
+                fr.pc = 3;
+                t.frames.push_back({ Frame::Kind::STMT, 0, f->body.get() });
+            }
+            break;
+        }
+        case 3:
+            fr.pc = 4;
+            push_expr(t, f->step.get());
+            break;
+        default:
+            t.values.pop_back();
+            fr.pc = 2;
+            push_expr(t, f->cond.get());
+            break;
+        }
+    }
+    else if (dynamic_cast<YieldStmt*>(s)) {
+        t.frames.pop_back();
+        return Status::YIELD;
+    }
+    else if (auto p = dynamic_cast<PrintStmt*>(s)) {
+        // 与 exec 一致：每个表达式求值后立即输出
+        if (fr.pc > 0) {
+            if (fr.pc > 1) std::cout << " ";
+            print_value(pop_value(t));
+        }
+        if (fr.pc < static_cast<int>(p->exprs.size())) {
+            Expr* next = p->exprs[fr.pc++].get();
+            push_expr(t, next);
+        }
+        else {
+            std::cout << "\n";
+            t.frames.pop_back();
+        }
+    }
+    else if (auto sp = dynamic_cast<SpawnStmt*>(s)) {
+        int argc = static_cast<int>(sp->call->args.size());
+        if (fr.pc < argc) {
+            Expr* next = sp->call->args[fr.pc++].get();
+            push_expr(t, next);
+            return Status::RUN;
+        }
+        std::vector<Value> args(std::make_move_iterator(t.values.end() - argc), std::make_move_iterator(t.values.end()));
+        t.values.resize(t.values.size() - argc);
+        t.frames.pop_back();
+        spawn(sp->call.get(), args);
+    }
+    else {
+        Expr* e = nullptr;
+        auto l = dynamic_cast<LetStmt*>(s);
+        auto r = dynamic_cast<ReturnStmt*>(s);
+        if (l) e = l->expr.get();
+        else if (r) e = r->expr.get();
+        else if (auto a = dynamic_cast<AssignStmt*>(s)) e = a->assign.get();
+        else if (auto es = dynamic_cast<ExprStmt*>(s)) e = es->expr.get();
+
+        if (!e) {
+            exec(s);
+            t.frames.pop_back();
+        }
+        else if (fr.pc == 0) {
+            fr.pc = 1;
+            push_expr(t, e);
+        }
+        else {
+            Value val = pop_value(t);
+            t.frames.pop_back();
+            if (l) current_scope()[l->name] = std::move(val);
+            else if (r) finish_call(t, std::move(val));
+        }
+    }
+    return Status::RUN;
+}
+
+// 逐帧执行协程直到它让出、阻塞或结束
+Interpreter::Status Interpreter::run_task(Task& t) {
+    while (!t.frames.empty()) {
+        Status st;
+        try {
+            st = t.frames.back().kind == Frame::Kind::EXPR ? step_expr(t) : step_stmt(t);
+        }
+        catch (ReturnException& re) {
+            // 计数循环的循环体经由 exec 执行，其中的 return 以异常形式返回
+            finish_call(t, re.val);
+            continue;
+        }
+        if (st != Status::RUN) return st;
+    }
+    return Status::DONE;
+}
+
+void Interpreter::resume(std::unique_ptr<Task> t) {
+    std::swap(scopes, t->scopes);
+    t->waiting = -1;
+    Status st;
+    try {
+        st = run_task(*t);
+    }
+    catch (...) {
+        std::swap(scopes, t->scopes);
+        throw;
+    }
+    std::swap(scopes, t->scopes);
+    if (st == Status::YIELD) ready.push_back(std::move(t));
+    else if (st == Status::BLOCK) channels[t->waiting].waiters.push_back(std::move(t));
+}
+
+// 就绪队列中的协程各运行一次，本轮中新就绪的协程留到下一轮
+void Interpreter::run_round() {
+    for (size_t n = ready.size(); n > 0 && !ready.empty(); --n) {
+        auto t = std::move(ready.front());
+        ready.pop_front();
+        resume(std::move(t));
+    }
+}
+
+void Interpreter::run_ready() {
+    while (!ready.empty()) run_round();
+}
+
+void Interpreter::run_tasks() {
+    run_ready();
+    size_t blocked = 0;
+    for (auto& ch : channels) blocked += ch.waiters.size();
+    if (blocked) throw std::runtime_error("deadlock: " + std::to_string(blocked) + " task(s) blocked on recv");
+}
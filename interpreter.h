@@ -8,11 +8,14 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <deque>
 
-using Value = std::variant<int, std::string>;
+using Scope = std::unordered_map<Name, Value, NameHash, std::equal_to<Name>,
+	CountingAllocator<std::pair<const Name, Value>, MemCategory::SCOPE>>;
+using ScopeStack = std::vector<Scope, CountingAllocator<Scope, MemCategory::SCOPE>>;
 
 struct Function {
-	std::vector<std::string> params;
+	std::vector<Name, CountingAllocator<Name, MemCategory::FUNCTION>> params;
 	std::unique_ptr<Stmt> body;
 };
 
@@ -21,19 +24,72 @@ struct ReturnException {
 	explicit ReturnException(Value v) : val(v) {}
 };
 
+// 协程的可恢复执行帧。语句和含调用的表达式都按帧逐步执行，
+// 因此协程可以在任意调用深度挂起，且挂起时不占用本地栈。
+struct Frame {
+	enum class Kind : unsigned char { STMT, EXPR, CALL };
+	Kind kind;
+	int pc = 0;                       // 节点内部的执行进度
+	Node* node;                       // STMT: 当前语句; EXPR: 当前表达式; CALL: 函数体
+	unsigned base = 0;                // CALL: 调用前的作用域深度
+	unsigned vbase = 0;               // CALL: 调用前的值栈深度
+	std::shared_ptr<Function> fn;     // CALL: 协程挂起期间保持函数体存活
+};
+
+struct Task {
+	ScopeStack scopes;                // 局部作用域，全局变量与其他协程共享
+	std::vector<Frame, CountingAllocator<Frame, MemCategory::TASK>> frames;
+	std::vector<Value, CountingAllocator<Value, MemCategory::TASK>> values; // 表达式求值的值栈
+	int waiting = -1;                 // 阻塞等待的通道
+
+	static void* operator new(size_t n) { return mem_allocate(MemCategory::TASK, n); }
+	static void operator delete(void* p, size_t n) { mem_deallocate(MemCategory::TASK, p, n); }
+};
+
+struct Channel {
+	std::deque<Value, CountingAllocator<Value, MemCategory::TASK>> items;
+	std::deque<std::unique_ptr<Task>, CountingAllocator<std::unique_ptr<Task>, MemCategory::TASK>> waiters;  // 阻塞在 recv 上的协程
+};
+
 class Interpreter {
-	std::vector<std::unordered_map<std::string, Value>> scopes;
-	std::unordered_map<std::string, std::unique_ptr<Function>> funcs;
+	enum class Status { RUN, YIELD, BLOCK, DONE };
+
+	Scope globals;
+	ScopeStack scopes;                // 当前执行上下文的局部作用域
+	std::unordered_map<Name, std::shared_ptr<Function>, NameHash, std::equal_to<Name>,
+		CountingAllocator<std::pair<const Name, std::shared_ptr<Function>>, MemCategory::FUNCTION>> funcs;
+
+	// 每个协程只会出现在就绪队列、某个通道的等待队列或正在运行三者之一
+	std::deque<std::unique_ptr<Task>, CountingAllocator<std::unique_ptr<Task>, MemCategory::TASK>> ready;
+	std::deque<Channel, CountingAllocator<Channel, MemCategory::TASK>> channels;
 
 	void push_scope();
 	void pop_scope();
+	Scope& current_scope();
+	Value* lookup(const Name& name);
+	void assign(const Name& name, const Value& val);
 
 	Value eval(Expr* e);
+	bool exec_counted(ForStmt* f);
 
-public:
-	Interpreter(); // global scope
+	Channel& channel(const Value& id);
+	Value make_chan();
+	void send(Channel& ch, Value val);
+	void spawn(CallExpr* c, std::vector<Value>& args);
+	void push_expr(Task& t, Expr* e);
+	void finish_call(Task& t, Value val);
+	Status step_expr(Task& t);
+	Status step_stmt(Task& t);
+	Status run_task(Task& t);
+	void resume(std::unique_ptr<Task> t);
+	void run_round();
 
+public:
 	void exec(Stmt* s);
+	void run_ready(); // 运行就绪的协程直到全部结束或阻塞
+	void run_tasks(); // 运行所有协程直到结束
+	void recover();   // 出错后丢弃残留的局部作用域
+	std::shared_ptr<Function> function(const Name& name) const;
 };
 
 #endif // INTERPRETER_H
\ No newline at end of file
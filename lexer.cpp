@@ -33,6 +33,7 @@ size_t Lexer::getline(size_t start) {
 Token Lexer::next() {
 	// skip whitespace
 	while (pos < src.size() && std::isspace((unsigned char)src[pos])) pos++;
+	tokStart = pos;
 	if (pos >= src.size()) return { TokenType::END, "", getline(pos) };
 
 	char c = src[pos];
@@ -60,6 +61,8 @@ Token Lexer::next() {
 		if (word == "for")   return { TokenType::FOR, word, getline(start) };
 		if (word == "func")  return { TokenType::FUNC, word, getline(start) };
 		if (word == "return") return { TokenType::RETURN, word , getline(start) };
+		if (word == "spawn") return { TokenType::SPAWN, word , getline(start) };
+		if (word == "yield") return { TokenType::YIELD, word , getline(start) };
 		return { TokenType::IDENT, word, getline(start) };
 	}
 
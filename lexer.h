@@ -7,7 +7,7 @@
 #include <unordered_map>
 enum class TokenType {
 	// Operators and Punctuation
-	LET, PRINT, IF, ELSE, FOR, FUNC, RETURN,
+	LET, PRINT, IF, ELSE, FOR, FUNC, RETURN, SPAWN, YIELD,
 
 	IDENT, NUMBER, STRING,
 
@@ -30,6 +30,7 @@ class Lexer {
 public:
 	Lexer(const std::string& source);
 	Token next();
+	size_t tokenStart() const { return tokStart; } // 最近一个词元在源码中的起始位置
 
 private:
 
@@ -40,6 +41,7 @@ private:
 	int line;
 	int column;
 	size_t pos = 0;
+	size_t tokStart = 0;
 
 
 	char peek();
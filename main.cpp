@@ -2,20 +2,70 @@
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <memory>
+#include <cctype>
+#include <cstdint>
 
 #include "lexer.h"
 #include "parser.h"
 #include "interpreter.h"
+#include "repl.h"
+#include "memory.h"
+
+// 解析 --max-memory 的参数，支持 K/M/G 后缀。0、负数和溢出都会关闭限制，必须拒绝
+static bool parse_size(const std::string& text, size_t& bytes) {
+	if (text.empty() || !std::isdigit((unsigned char)text[0])) return false;
+	size_t used = 0;
+	unsigned long long n;
+	try { n = std::stoull(text, &used); }
+	catch (const std::exception&) { return false; }
+	std::string suffix = text.substr(used);
+	int shift = 0;
+	if (suffix == "K" || suffix == "k") shift = 10;
+	else if (suffix == "M" || suffix == "m") shift = 20;
+	else if (suffix == "G" || suffix == "g") shift = 30;
+	else if (!suffix.empty()) return false;
+	if (n == 0 || n > (SIZE_MAX >> shift)) return false;
+	bytes = static_cast<size_t>(n) << shift;
+	return true;
+}
 
 int main(int argc, char* argv[]) {
 	std::string filename;
+	bool repl = false;
+	bool mem_stats = false;
 
-	if (argc < 2) {
-		filename = "script.gg";
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "-i" || arg == "--repl") repl = true;
+		else if (arg == "--mem-stats") mem_stats = true;
+		else if (arg == "--max-memory") {
+			size_t limit;
+			if (i + 1 >= argc || !parse_size(argv[++i], limit)) {
+				std::cerr << "--max-memory expects a size such as 65536, 512K or 64M\n";
+				return 1;
+			}
+			mem_set_limit(limit);
+		}
+		else filename = arg;
 	}
-	else {
-		filename = argv[1];
+
+	// gg --repl [file]：交互模式，可先加载一个脚本
+	if (repl) {
+		int rc;
+		try {
+			Repl r;
+			rc = r.loop(filename);
+		}
+		catch (const std::exception& e) {
+			// 只有创建解释器本身失败（如 --max-memory 过小）才会到这里
+			std::cerr << "Error: " << e.what() << "\n";
+			rc = 1;
+		}
+		if (mem_stats) mem_report(std::cerr);
+		return rc;
 	}
+	if (filename.empty()) filename = "script.gg";
 
 	std::ifstream file(filename);
 	if (!file) { std::cerr << "Cannot open file: " << filename << "\n"; return 1; }
@@ -24,23 +74,30 @@ int main(int argc, char* argv[]) {
 	buffer << file.rdbuf();
 	std::string code = buffer.str();
 
+	int rc = 0;
+	std::unique_ptr<Interpreter> interp; // 在 try 内创建：--max-memory 过小时构造也可能失败
 	try {
+		interp = std::make_unique<Interpreter>();
 		Lexer lexer(code);
 		Parser parser(lexer);
-		Interpreter interp;
 
 		while (true) {
 			auto stmt = parser.parseStmt();
 			if (!stmt) break;
-			interp.exec(stmt.get());
+			interp->exec(stmt.get());
 		}
+		interp->run_tasks();
 	}
+	// 运行中止时返回非零状态，便于调用方识别（包括超出 --max-memory）
 	catch (ReturnException&) {
 		std::cerr << "Error: return statement outside of function\n";
+		rc = 1;
 	}
 	catch (const std::exception& e) {
 		std::cerr << "Error: " << e.what() << "\n";
+		rc = 1;
 	}
 
-	return 0;
-}
\ No newline at end of file
+	if (mem_stats) mem_report(std::cerr);
+	return rc;
+}
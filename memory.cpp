@@ -0,0 +1,48 @@
+#include "memory.h"
+#include <iomanip>
+#include <new>
+
+struct MemStats {
+	size_t current = 0;
+	size_t peak = 0;
+};
+
+static MemStats stats[static_cast<size_t>(MemCategory::COUNT)];
+static MemStats total;
+static size_t limit = 0;
+
+static void add(MemStats& s, size_t n) {
+	s.current += n;
+	if (s.current > s.peak) s.peak = s.current;
+}
+
+void* mem_allocate(MemCategory c, size_t n) {
+	if (limit && total.current + n > limit)
+		throw MemoryLimitError("memory limit exceeded (" + std::to_string(limit) + " bytes)");
+	void* p = ::operator new(n);
+	add(stats[static_cast<size_t>(c)], n);
+	add(total, n);
+	return p;
+}
+
+void mem_deallocate(MemCategory c, void* p, size_t n) {
+	::operator delete(p);
+	stats[static_cast<size_t>(c)].current -= n;
+	total.current -= n;
+}
+
+void mem_set_limit(size_t bytes) {
+	limit = bytes;
+}
+
+void mem_report(std::ostream& os) {
+	static const char* names[] = { "strings", "names", "scopes", "functions", "ast", "tasks" };
+	os << std::left << std::setw(10) << "memory" << std::right << std::setw(14) << "current" << std::setw(14) << "peak" << "\n";
+	for (size_t i = 0; i < static_cast<size_t>(MemCategory::COUNT); i++) {
+		os << std::left << std::setw(10) << names[i] << std::right
+			<< std::setw(14) << stats[i].current << std::setw(14) << stats[i].peak << "\n";
+	}
+	os << std::left << std::setw(10) << "total" << std::right
+		<< std::setw(14) << total.current << std::setw(14) << total.peak << "\n";
+	if (limit) os << "limit: " << limit << " bytes\n";
+}
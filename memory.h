@@ -0,0 +1,36 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+// 解释器内存按类别统计，超过 --max-memory 时抛出 MemoryLimitError
+enum class MemCategory { STRING, NAME, SCOPE, FUNCTION, AST, TASK, COUNT };
+
+struct MemoryLimitError : std::runtime_error {
+	explicit MemoryLimitError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+void* mem_allocate(MemCategory c, size_t n);
+void mem_deallocate(MemCategory c, void* p, size_t n);
+void mem_set_limit(size_t bytes); // 0 表示不限制
+void mem_report(std::ostream& os);
+
+template <class T, MemCategory C>
+struct CountingAllocator {
+	using value_type = T;
+	template <class U> struct rebind { using other = CountingAllocator<U, C>; };
+
+	CountingAllocator() = default;
+	template <class U> CountingAllocator(const CountingAllocator<U, C>&) {}
+
+	T* allocate(size_t n) { return static_cast<T*>(mem_allocate(C, n * sizeof(T))); }
+	void deallocate(T* p, size_t n) { mem_deallocate(C, p, n * sizeof(T)); }
+
+	template <class U> bool operator==(const CountingAllocator<U, C>&) const { return true; }
+	template <class U> bool operator!=(const CountingAllocator<U, C>&) const { return false; }
+};
+
+#endif // MEMORY_H
@@ -4,7 +4,10 @@
 
 Parser::Parser(Lexer& l) :lexer(l) { advance(); }
 
-void Parser::advance() { cur = lexer.next(); }
+void Parser::advance() {
+	cur = lexer.next();
+	curStart = lexer.tokenStart();
+}
 
 bool Parser::match(TokenType t) {
 	if (cur.type == t) {
@@ -20,13 +23,13 @@ std::unique_ptr<Expr> Parser::parsePrimary() {
 		return std::make_unique<NumberExpr>(val);
 	}
 	if (cur.type == TokenType::STRING) {
-		std::string s = cur.text; advance();
+		AstString s(cur.text.data(), cur.text.size()); advance();
 		return std::make_unique<StringExpr>(s);
 	}
 	if (cur.type == TokenType::IDENT) {
-		std::string name = cur.text; advance();
+		Name name(cur.text.data(), cur.text.size()); advance();
 		if (match(TokenType::LPAREN)) {
-			std::vector<std::unique_ptr<Expr>> args;
+			AstVector<std::unique_ptr<Expr>> args;
 			if (!match(TokenType::RPAREN)) {
 				do {
 					args.push_back(parseExpr());
@@ -89,7 +92,7 @@ std::unique_ptr<Expr> Parser::parseAssign() {
 
 		auto* v = dynamic_cast<VarExpr*>(left.get());
 		if (!v) throw std::runtime_error("left of assignment must be variable");
-		std::string name = v->name;
+		Name name = v->name;
 		TokenType opType = cur.type;
 		advance();
 		auto right = parseAssign();
@@ -113,7 +116,7 @@ std::unique_ptr<Expr> Parser::parseAssign() {
 	else if (cur.type == TokenType::PLUS_PLUS_ASSIGN || cur.type == TokenType::MINUS_MINUS_ASSIGN) {
 		auto* v = dynamic_cast<VarExpr*>(left.get());
 		if (!v) throw std::runtime_error("left of assignment must be variable");
-		std::string name = v->name;
+		Name name = v->name;
 		TokenType opType = cur.type;
 		std::string op;
 		advance(); // 移动一个词
@@ -131,7 +134,7 @@ std::unique_ptr<Expr> Parser::parseExpr() { return parseAssign(); }
 
 std::unique_ptr<Stmt> Parser::parseStmt() {
 	if (match(TokenType::PRINT)) {
-		std::vector<std::unique_ptr<Expr>> exprs;
+		AstVector<std::unique_ptr<Expr>> exprs;
 		exprs.push_back(parseExpr());
 		while (match(TokenType::COMMA)) {
 			exprs.push_back(parseExpr());
@@ -141,7 +144,7 @@ std::unique_ptr<Stmt> Parser::parseStmt() {
 	}
 	if (match(TokenType::LET)) {
 		if (cur.type != TokenType::IDENT) throw std::runtime_error("expected identifier");
-		std::string name = cur.text; advance();
+		Name name(cur.text.data(), cur.text.size()); advance();
 		if (!match(TokenType::ASSIGN)) throw std::runtime_error("expected =");
 		auto e = parseExpr();
 		if (!match(TokenType::SEMICOLON)) throw std::runtime_error("expected ; after let");
@@ -177,13 +180,13 @@ std::unique_ptr<Stmt> Parser::parseStmt() {
 	}
 	if (match(TokenType::FUNC)) {
 		if (cur.type != TokenType::IDENT) throw std::runtime_error("expected function name");
-		std::string name = cur.text; advance();
+		Name name(cur.text.data(), cur.text.size()); advance();
 		if (!match(TokenType::LPAREN)) throw std::runtime_error("expected ( after function name");
-		std::vector<std::string> params;
+		AstVector<Name> params;
 		if (cur.type != TokenType::RPAREN) {
 			do {
 				if (cur.type != TokenType::IDENT) throw std::runtime_error("expected parameter name");
-				params.push_back(cur.text);
+				params.emplace_back(cur.text.data(), cur.text.size());
 				advance();
 			} while (match(TokenType::COMMA));
 		}
@@ -196,6 +199,18 @@ std::unique_ptr<Stmt> Parser::parseStmt() {
 		if (!match(TokenType::SEMICOLON)) throw std::runtime_error("expected ; after return");
 		return std::make_unique<ReturnStmt>(std::move(e));
 	}
+	if (match(TokenType::SPAWN)) {
+		auto e = parsePrimary();
+		auto* c = dynamic_cast<CallExpr*>(e.get());
+		if (!c) throw std::runtime_error("expected function call after spawn");
+		if (!match(TokenType::SEMICOLON)) throw std::runtime_error("expected ; after spawn");
+		e.release();
+		return std::make_unique<SpawnStmt>(std::unique_ptr<CallExpr>(c));
+	}
+	if (match(TokenType::YIELD)) {
+		if (!match(TokenType::SEMICOLON)) throw std::runtime_error("expected ; after yield");
+		return std::make_unique<YieldStmt>();
+	}
 	if (match(TokenType::LBRACE)) {
 		auto block = std::make_unique<BlockStmt>();
 		while (cur.type != TokenType::RBRACE && cur.type != TokenType::END) {
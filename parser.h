@@ -7,6 +7,7 @@
 class Parser {
 	Lexer& lexer;
 	Token cur;
+	size_t curStart = 0;
 
 	void advance();
 	bool match(TokenType t);
@@ -22,6 +23,7 @@ public:
 	Parser(Lexer& l);
 
 	std::unique_ptr<Stmt> parseStmt();
+	size_t offset() const { return curStart; } // 下一条语句在源码中的起始位置
 };
 
 #endif // PARSER_H
\ No newline at end of file
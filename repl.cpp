@@ -0,0 +1,154 @@
+#include "repl.h"
+#include "lexer.h"
+#include "parser.h"
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+static std::string trim(const std::string& s) {
+	size_t b = s.find_first_not_of(" \t\r\n");
+	if (b == std::string::npos) return "";
+	size_t e = s.find_last_not_of(" \t\r\n");
+	return s.substr(b, e - b + 1);
+}
+
+// 输入是否构成完整的语句：括号配平且以 ; 或 } 结尾
+static bool complete(const std::string& code) {
+	int depth = 0;
+	bool in_str = false;
+	for (size_t i = 0; i < code.size(); i++) {
+		char c = code[i];
+		if (in_str) {
+			if (c == '\\') i++;
+			else if (c == '"') in_str = false;
+		}
+		else if (c == '"') in_str = true;
+		else if (c == '{' || c == '(') depth++;
+		else if (c == '}' || c == ')') depth--;
+	}
+	std::string t = trim(code);
+	return !in_str && depth <= 0 && !t.empty() && (t.back() == ';' || t.back() == '}');
+}
+
+// s 是否以关键字 word 开头
+static bool starts_with_word(const std::string& s, const std::string& word) {
+	if (s.rfind(word, 0) != 0) return false;
+	return s.size() == word.size() || !(std::isalnum((unsigned char)s[word.size()]) || s[word.size()] == '_');
+}
+
+// 以 } 结尾的 if 语句可能在下一行跟着 else
+static bool awaits_else(const std::string& input) {
+	std::string s = input.rfind(":time ", 0) == 0 ? trim(input.substr(6)) : input;
+	return !s.empty() && s.back() == '}' && starts_with_word(s, "if");
+}
+
+// 只对新输入的源码做词法和语法分析。源码未变的函数定义直接跳过，
+// 沿用已有的函数体及其上缓存的分析结果。
+void Repl::run(const std::string& code) {
+	Lexer lexer(code);
+	Parser parser(lexer);
+	while (true) {
+		size_t start = parser.offset();
+		auto stmt = parser.parseStmt();
+		if (!stmt) break;
+		if (auto fd = dynamic_cast<FunctionDefStmt*>(stmt.get())) {
+			std::string text = trim(code.substr(start, parser.offset() - start));
+			auto it = defs.find(fd->name);
+			if (it != defs.end() && it->second.text == text) {
+				auto current = interp.function(fd->name);
+				if (current && current == it->second.fn.lock()) {
+					reused++;
+					continue;
+				}
+			}
+			interp.exec(stmt.get());
+			defs[fd->name] = { text, interp.function(fd->name) };
+			compiled++;
+			continue;
+		}
+		interp.exec(stmt.get());
+	}
+	// parseStmt 无法开始一条语句时返回 nullptr，剩余输入不能静默丢弃
+	if (parser.offset() < code.size()) {
+		size_t end = code.find_first_of(" \t\r\n", parser.offset());
+		throw std::runtime_error("unexpected token: " + code.substr(parser.offset(), end - parser.offset()));
+	}
+	interp.run_ready();
+}
+
+void Repl::load(const std::string& filename) {
+	std::ifstream file(filename);
+	if (!file) throw std::runtime_error("cannot open file: " + filename);
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	compiled = reused = 0;
+	run(buffer.str());
+	std::cout << "loaded " << filename << ": " << compiled << " function(s) compiled, " << reused << " unchanged\n";
+}
+
+void Repl::time(const std::string& code) {
+	auto begin = std::chrono::steady_clock::now();
+	run(code);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+	std::cout << "time: " << std::fixed << std::setprecision(3) << elapsed.count() << " ms\n";
+	std::cout.unsetf(std::ios::floatfield);
+}
+
+bool Repl::command(const std::string& line) {
+	try {
+		if (line == ":quit" || line == ":q") return false;
+		if (line.rfind(":load ", 0) == 0) load(trim(line.substr(6)));
+		else if (line.rfind(":time ", 0) == 0) time(line.substr(6));
+		else if (line[0] == ':') std::cerr << "unknown command: " << line << " (:load <file>, :time <stmt>, :quit)\n";
+		else run(line);
+	}
+	catch (ReturnException&) {
+		std::cerr << "Error: return statement outside of function\n";
+		interp.recover();
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Error: " << e.what() << "\n";
+		interp.recover();
+	}
+	return true;
+}
+
+int Repl::loop(const std::string& filename) {
+	if (!filename.empty()) command(":load " + filename);
+	std::string buffer, pending, line;
+	std::cout << "gg> " << std::flush;
+	while (std::getline(std::cin, line)) {
+		// 暂存的 if 语句：下一行以 else 开头则继续拼接，否则先执行它
+		if (!pending.empty()) {
+			std::string input = pending;
+			pending.clear();
+			if (starts_with_word(trim(line), "else")) buffer = input + "\n";
+			else if (!command(input)) return 0;
+		}
+		if (buffer.empty() && trim(line).empty()) {
+			std::cout << "gg> " << std::flush;
+			continue;
+		}
+		buffer += line + "\n";
+		// :time 后的语句同样可以跨行输入
+		if ((buffer[0] == ':' && buffer.rfind(":time ", 0) != 0) || complete(buffer)) {
+			std::string input = trim(buffer);
+			buffer.clear();
+			if (awaits_else(input)) {
+				pending = input;
+				std::cout << "... " << std::flush;
+				continue;
+			}
+			if (!command(input)) return 0;
+			std::cout << "gg> " << std::flush;
+		}
+		else std::cout << "... " << std::flush;
+	}
+	if (!pending.empty()) command(pending);
+	std::cout << "\n";
+	return 0;
+}
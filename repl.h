@@ -0,0 +1,30 @@
+#ifndef REPL_H
+#define REPL_H
+
+#include "interpreter.h"
+#include <string>
+#include <unordered_map>
+#include <memory>
+
+// 交互式解释器：所有输入共享同一个 Interpreter，变量和函数在输入之间保留
+class Repl {
+	Interpreter interp;
+	// 顶层函数定义的源码及其编译结果。函数可能在块、函数体或协程中被重新定义，
+	// 因此只有 funcs 中当前的函数仍是这次编译的结果时才能复用。
+	struct Def {
+		std::string text;
+		std::weak_ptr<Function> fn;
+	};
+	std::unordered_map<Name, Def, NameHash> defs;
+	int compiled = 0, reused = 0;
+
+	void run(const std::string& code);
+	void load(const std::string& filename);
+	void time(const std::string& code);
+	bool command(const std::string& line); // 返回 false 表示退出
+
+public:
+	int loop(const std::string& filename = "");
+};
+
+#endif // REPL_H